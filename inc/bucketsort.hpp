@@ -8,6 +8,12 @@
 #include <string>
 #include <thread>
 #include <mutex>
+#include <barrier>
+#include <future>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
 
 using std::vector;
 using std::string;
@@ -29,6 +35,10 @@ void pressEnterToContinue();
 void step1();
 void step2();
 void step3();
+void scatterIntoBuckets(const unsigned int* data, const unsigned int size, vector<unsigned int>* bucketSet, const unsigned int bucketCount);
+void gatherFromBuckets(unsigned int* data, vector<unsigned int>* bucketSet, const unsigned int bucketCount);
+void pipelinedBucketSort(const vector<unsigned int*>& batches, const unsigned int batchSize, const unsigned int bucketCount, const unsigned int threadCount);
+std::future<void> asyncBucketSort(unsigned int* data, const unsigned int size, const unsigned int bucketCount, const unsigned int threadCount);
 
 //***GLOBAL VARIABLES***  (These are global as they will help with an upcoming multithreaded assignment)
 unsigned int numBuckets{ 0 };
@@ -49,25 +59,29 @@ void step1() {
   // Determine which bucket an array value should go into, 
   // then assign that array value into that bucket.
   //buckets[computedBucket].push_back(arr[i]);
+  scatterIntoBuckets(arr, arrSize, buckets, numBuckets);
+}
 
+// Step 1 on any array/bucket set, so the pipelined sort can scatter one batch while other batches are in flight.
+void scatterIntoBuckets(const unsigned int* data, const unsigned int size, vector<unsigned int>* bucketSet, const unsigned int bucketCount) {
   //find range per bucket
-  unsigned int rangePer = UINTMAX/numBuckets + 1;
+  unsigned int rangePer = UINTMAX/bucketCount + 1;
   unsigned int bucketNum {0};
   //iterating through the array
-  for(unsigned int i = 0; i < arrSize; i++){
+  for(unsigned int i = 0; i < size; i++){
 
 
       //if there is only one bucket, put all entries into that bucket. otherwise sort into according buckets
-      if(numBuckets == 1){
+      if(bucketCount == 1){
           bucketNum = 0;
       } else {
           //find the bucket to put the entry in
-          bucketNum = arr[i] / rangePer;
+          bucketNum = data[i] / rangePer;
       }//end if/else statement
 
       //put entry in its appropriate bucket
-      buckets[bucketNum].push_back(arr[i]);
-  }//end for loop iterating through arr
+      bucketSet[bucketNum].push_back(data[i]);
+  }//end for loop iterating through data
 }
 
 void singleThreadedStep2() {
@@ -119,15 +133,19 @@ void step3() {
   // Index of which bucket you are working with
   // Index of a value in that particular bucket
   // Index of your next open spot in the output array
+  gatherFromBuckets(arr, buckets, numBuckets);
+}
 
-  int k = 0; //this is the array index we will insert at
+// Step 3 on any array/bucket set, the counterpart of scatterIntoBuckets().
+void gatherFromBuckets(unsigned int* data, vector<unsigned int>* bucketSet, const unsigned int bucketCount) {
+  unsigned int k = 0; //this is the array index we will insert at
 
   //i will correspond to the bucket we are in. j will be the index of that bucket. We will do nested for loops
-  //that insert buckets[i][j] into arr[k], and then increment k
+  //that insert bucketSet[i][j] into data[k], and then increment k
 
-  for(unsigned int i = 0; i < numBuckets; i++){
-      for(unsigned int j = 0; j < buckets[i].size(); j++){
-          arr[k] = buckets[i][j];
+  for(unsigned int i = 0; i < bucketCount; i++){
+      for(unsigned int j = 0; j < bucketSet[i].size(); j++){
+          data[k] = bucketSet[i][j];
           k++;
       }
   }//end nested for loop
@@ -191,6 +209,233 @@ void multiThreadedBucketSort() {
   printArray("After Step 3"); //useful for debugging small amounts of numbers.  
 }
 
+// *** Pipelined and asynchronous sorting ***
+// A stream of batches is sorted in "ticks".  During each tick, the same worker threads scatter the newest batch
+// (step 1), sort the buckets of the batch before it (step 2), and gather the batch before that (step 3), so the
+// serial steps of one batch overlap with the parallel step of another instead of leaving cores idle.  Three
+// bucket sets rotate between the batches in flight.  Work units are handed out like multiThreadedStep2():
+// unit 0 is the scatter, unit 1 is the gather (the two long ones go first), and units 2 and up are the buckets
+// of the batch being sorted.
+const unsigned int PIPELINE_DEPTH = 3;
+
+// One batch moving through the pipeline
+struct PipelineBatch {
+  unsigned int* data{ nullptr };
+  unsigned int size{ 0 };
+  unsigned int bucketSlot{ 0 };
+  bool active{ false };
+  std::promise<void> done;
+};
+
+// Keeps a set of worker threads alive between sorts.  submit() queues a batch and returns a future that becomes
+// ready once that batch has been gathered back into its array, so the caller can ship each batch as soon as it is
+// done while later batches are still being sorted.  Batches finish in the order they were submitted.
+// A bucketCount or threadCount of 0 is treated as 1.  The destructor finishes every submitted batch first.
+class BucketSortPipeline {
+public:
+  BucketSortPipeline(const unsigned int bucketCount, const unsigned int threadCount);
+  ~BucketSortPipeline();
+  BucketSortPipeline(const BucketSortPipeline&) = delete;
+  BucketSortPipeline& operator=(const BucketSortPipeline&) = delete;
+
+  std::future<void> submit(unsigned int* data, const unsigned int size);
+
+private:
+  // Runs once per tick when every worker has reached the barrier.  Moves the pipeline forward one stage.
+  struct TickAdvance {
+    BucketSortPipeline* pipeline;
+    void operator()() noexcept;
+  };
+
+  void worker();
+  void runWorkUnit(const unsigned int workUnit);
+  void advanceTick();
+
+  unsigned int bucketCount{ 0 };
+  unsigned int threadCount{ 0 };
+  vector<vector<unsigned int>> bucketSlots[PIPELINE_DEPTH];
+  unsigned int nextBucketSlot{ 0 };
+
+  // Only changed by advanceTick(), while every worker is waiting at the barrier
+  PipelineBatch scatterBatch;
+  PipelineBatch sortBatch;
+  PipelineBatch gatherBatch;
+  bool stopped{ false };
+
+  unsigned int nextWorkUnit{ 0 };
+  mutex workUnitMutex;
+
+  std::deque<PipelineBatch> waitingBatches;
+  bool stopping{ false };
+  mutex queueMutex;
+  std::condition_variable batchSubmitted;
+
+  std::barrier<TickAdvance> tickBarrier;
+  thread* threadTrackers{ nullptr };
+};
+
+BucketSortPipeline::BucketSortPipeline(const unsigned int bucketCount, const unsigned int threadCount)
+  : bucketCount((bucketCount == 0) ? 1 : bucketCount),
+    threadCount((threadCount == 0) ? 1 : threadCount),
+    tickBarrier((threadCount == 0) ? 1 : threadCount, TickAdvance{ this }) {
+  for (unsigned int i = 0; i < PIPELINE_DEPTH; i++) {
+    bucketSlots[i].resize(this->bucketCount);
+  }
+
+  //fork
+  threadTrackers = new thread[this->threadCount];
+  for (unsigned int i = 0; i < this->threadCount; i++) {
+    threadTrackers[i] = thread(&BucketSortPipeline::worker, this);
+  }
+}
+
+BucketSortPipeline::~BucketSortPipeline() {
+  queueMutex.lock();
+  stopping = true;
+  queueMutex.unlock();
+  batchSubmitted.notify_all();
+
+  //join
+  for (unsigned int i = 0; i < threadCount; i++) {
+    threadTrackers[i].join();
+  }
+  delete[] threadTrackers;
+}
+
+std::future<void> BucketSortPipeline::submit(unsigned int* data, const unsigned int size) {
+  PipelineBatch batch;
+  batch.data = data;
+  batch.size = size;
+  batch.active = true;
+  std::future<void> done = batch.done.get_future();
+
+  queueMutex.lock();
+  waitingBatches.push_back(std::move(batch));
+  queueMutex.unlock();
+  batchSubmitted.notify_one();
+
+  return done;
+}
+
+void BucketSortPipeline::TickAdvance::operator()() noexcept {
+  pipeline->advanceTick();
+}
+
+void BucketSortPipeline::advanceTick() {
+  // The batch gathered this tick is finished
+  if (gatherBatch.active) {
+    gatherBatch.done.set_value();
+  }
+
+  gatherBatch = std::move(sortBatch);
+  sortBatch = std::move(scatterBatch);
+  scatterBatch = PipelineBatch();
+
+  std::unique_lock<mutex> lock(queueMutex);
+  if (!gatherBatch.active && !sortBatch.active) {
+    // Nothing in flight.  Sleep here (the other workers are parked at the barrier) until there is more work.
+    batchSubmitted.wait(lock, [this]() { return !waitingBatches.empty() || stopping; });
+  }
+
+  if (!waitingBatches.empty()) {
+    // The slot two batches back was emptied by this tick's gather
+    scatterBatch = std::move(waitingBatches.front());
+    waitingBatches.pop_front();
+    scatterBatch.bucketSlot = nextBucketSlot;
+    nextBucketSlot = (nextBucketSlot + 1) % PIPELINE_DEPTH;
+  }
+  else if (stopping && !gatherBatch.active && !sortBatch.active) {
+    stopped = true;
+  }
+
+  nextWorkUnit = 0;
+}
+
+void BucketSortPipeline::runWorkUnit(const unsigned int workUnit) {
+  if (workUnit == 0) {
+    if (scatterBatch.active) {
+      scatterIntoBuckets(scatterBatch.data, scatterBatch.size, bucketSlots[scatterBatch.bucketSlot].data(), bucketCount);
+    }
+  }
+  else if (workUnit == 1) {
+    // Gather, then empty the buckets (keeping their capacity) for a later batch
+    if (gatherBatch.active) {
+      vector<vector<unsigned int>>& slot = bucketSlots[gatherBatch.bucketSlot];
+      gatherFromBuckets(gatherBatch.data, slot.data(), bucketCount);
+      for (unsigned int i = 0; i < bucketCount; i++) {
+        slot[i].clear();
+      }
+    }
+  }
+  else {
+    if (sortBatch.active) {
+      sortOneVector(bucketSlots[sortBatch.bucketSlot][workUnit - 2]);
+    }
+  }
+}
+
+void BucketSortPipeline::worker() {
+  const unsigned int workUnitsPerTick = 2 + bucketCount;
+
+  unsigned int localWorkUnit{ 0 };
+  while (true) {
+    //lock the mutex, get work unit, unlock mutex
+    workUnitMutex.lock();
+    localWorkUnit = nextWorkUnit;
+    nextWorkUnit += 1;
+    workUnitMutex.unlock();
+
+    if (localWorkUnit >= workUnitsPerTick) {
+      // Nothing left this tick.  Wait for the other workers, then either start the next tick or finish.
+      tickBarrier.arrive_and_wait();
+      if (stopped) {
+        break;
+      }
+      continue;
+    }
+
+    runWorkUnit(localWorkUnit);
+  }
+}
+
+// Sorts every batch (each batchSize values long) in place on one pipeline, overlapping the steps of successive
+// batches.  Blocks until all batches are sorted.  A bucketCount or threadCount of 0 is treated as 1.
+void pipelinedBucketSort(const vector<unsigned int*>& batches, const unsigned int batchSize, const unsigned int bucketCount, const unsigned int threadCount) {
+  if (batches.empty()) {
+    return;
+  }
+
+  BucketSortPipeline pipeline(bucketCount, threadCount);
+  vector<std::future<void>> pending;
+  for (unsigned int b = 0; b < batches.size(); b++) {
+    pending.push_back(pipeline.submit(batches[b], batchSize));
+  }
+  for (unsigned int b = 0; b < pending.size(); b++) {
+    pending[b].get();
+  }
+}
+
+// Pipelines used by asyncBucketSort(), one per bucket count and thread count.  They live until the program exits.
+std::map<std::pair<unsigned int, unsigned int>, std::unique_ptr<BucketSortPipeline>> sharedPipelines;
+mutex sharedPipelinesMutex;
+
+// Starts sorting data in the background and returns immediately.  The future becomes ready once data is sorted.
+// data must stay alive and untouched until then.  Calls with the same bucket and thread counts share one pipeline,
+// so their sorts overlap on one set of worker threads.
+std::future<void> asyncBucketSort(unsigned int* data, const unsigned int size, const unsigned int bucketCount, const unsigned int threadCount) {
+  const std::pair<unsigned int, unsigned int> key((bucketCount == 0) ? 1 : bucketCount, (threadCount == 0) ? 1 : threadCount);
+
+  sharedPipelinesMutex.lock();
+  std::unique_ptr<BucketSortPipeline>& pipeline = sharedPipelines[key];
+  if (!pipeline) {
+    pipeline = std::make_unique<BucketSortPipeline>(key.first, key.second);
+  }
+  BucketSortPipeline* sharedPipeline = pipeline.get();
+  sharedPipelinesMutex.unlock();
+
+  return sharedPipeline->submit(data, size);
+}
+
 // The function you want to use.  Just pass in a vector, and this will sort it.
 void sortOneVector(vector<unsigned int>& bucket) {
   _sortOneVector(bucket, 0u, (unsigned int)bucket.size());
@@ -7,6 +7,7 @@
 #include <iostream>
 #include <string>
 #include <cstring>
+#include <algorithm>
 
 using std::stringstream;
 using std::cout;
@@ -270,6 +271,190 @@ int testAll() {
   return testNum - 1 == correct;
 }
 
+// Checks a batch sorted outside the global array against its own expected contents, then checks the order
+// by pointing the global array at it for testSort()
+void testBatchSort(int testNum, int& correct, const string& sortTest, unsigned int* batch, const vector<unsigned int>& expected, unsigned int batchSize) {
+  std::chrono::duration<double, std::milli> noTime{ 0 };
+
+  for (unsigned int i = 0; i < batchSize; i++) {
+    if (batch[i] != expected[i]) {
+      printf("------------------------------------------------------\n");
+      printf("SORT TEST %s\n", sortTest.c_str());
+      printf("ERROR - This batch does not hold its own values.  At index %d is value %08X, expected %08X\n", i, batch[i], expected[i]);
+      printf("------------------------------------------------------\n");
+      return;
+    }
+  }
+
+  unsigned int* savedArr = arr;
+  unsigned int savedArrSize = arrSize;
+  arr = batch;
+  arrSize = batchSize;
+  testSort(testNum, correct, sortTest, noTime);
+  arr = savedArr;
+  arrSize = savedArrSize;
+}
+
+// Fills a list of batches with random values, seeded per batch so every batch holds different values.
+// expected receives a sorted copy of each batch.
+vector<unsigned int*> createBatches(unsigned int numBatches, unsigned int batchSize, vector<vector<unsigned int>>& expected) {
+  vector<unsigned int*> batches;
+  expected.clear();
+  std::uniform_int_distribution<unsigned long> dis(0, UINTMAX);
+  for (unsigned int b = 0; b < numBatches; b++) {
+    std::mt19937 gen(b + 1);
+    unsigned int* batch = new unsigned int[batchSize];
+    for (unsigned int i = 0; i < batchSize; i++) {
+      batch[i] = dis(gen);
+    }
+    batches.push_back(batch);
+    expected.push_back(vector<unsigned int>(batch, batch + batchSize));
+    std::sort(expected[b].begin(), expected[b].end());
+  }
+  return batches;
+}
+
+void deleteBatches(vector<unsigned int*>& batches) {
+  for (unsigned int b = 0; b < batches.size(); b++) {
+    delete[] batches[b];
+  }
+  batches.clear();
+}
+
+int testPipelinedSorts() {
+
+  int testNum = 1;
+  int correct = 0;
+  std::cout << "--------testPipelinedSorts Tests--------" << std::endl;
+
+  std::chrono::duration<double, std::milli> diff{ 0 };
+  vector<vector<unsigned int>> expected;
+
+  useMultiThreading = true;
+
+  // Two sorts through the future returning entry point, sharing one pipeline
+  numBuckets = 4;
+  numThreads = getNumThreadsToUse();
+  vector<unsigned int*> batches = createBatches(2, 100, expected);
+  printf("\nStarting async bucket sorts for 2 batches, listSize = %d, numBuckets = %d, numThreads = %d\n", 100, numBuckets, numThreads);
+  std::future<void> first = asyncBucketSort(batches[0], 100, numBuckets, numThreads);
+  std::future<void> second = asyncBucketSort(batches[1], 100, numBuckets, numThreads);
+  first.get();
+  second.get();
+  testBatchSort(testNum++, correct, "async batch 0 with 100 items in 4 buckets", batches[0], expected[0], 100); // 1
+  testBatchSort(testNum++, correct, "async batch 1 with 100 items in 4 buckets", batches[1], expected[1], 100); // 2
+  deleteBatches(batches);
+
+  // Zero buckets falls back to one bucket
+  batches = createBatches(1, 100, expected);
+  asyncBucketSort(batches[0], 100, 0, numThreads).get();
+  testBatchSort(testNum++, correct, "async 100 items in 0 buckets", batches[0], expected[0], 100); // 3
+  deleteBatches(batches);
+
+  // Each batch is checked as soon as its own future is ready, while later batches may still be in flight
+  {
+    batches = createBatches(5, 100, expected);
+    printf("\nStarting streamed bucket sort for 5 batches, listSize = %d, numBuckets = %d, numThreads = %d\n", 100, numBuckets, numThreads);
+    BucketSortPipeline pipeline(numBuckets, numThreads);
+    vector<std::future<void>> pending;
+    for (unsigned int b = 0; b < batches.size(); b++) {
+      pending.push_back(pipeline.submit(batches[b], 100));
+    }
+    for (unsigned int b = 0; b < batches.size(); b++) {
+      pending[b].get();
+      stringstream ss;
+      ss << "streamed batch " << b << " of 5 with 100 items in " << numBuckets << " buckets";
+      testBatchSort(testNum++, correct, ss.str(), batches[b], expected[b], 100);
+    }
+  }
+  deleteBatches(batches);
+
+  // No batches at all
+  pipelinedBucketSort(batches, 100, numBuckets, numThreads);
+
+  // Fewer batches than the pipeline is deep, then more
+  for (unsigned int numBatches = 1; numBatches <= 5; numBatches += 2) {
+    batches = createBatches(numBatches, 100, expected);
+    printf("\nStarting pipelined bucket sort for %d batches, listSize = %d, numBuckets = %d, numThreads = %d\n", numBatches, 100, numBuckets, numThreads);
+    pipelinedBucketSort(batches, 100, numBuckets, numThreads);
+    for (unsigned int b = 0; b < numBatches; b++) {
+      stringstream ss;
+      ss << "pipelined batch " << b << " of " << numBatches << " with 100 items in " << numBuckets << " buckets";
+      testBatchSort(testNum++, correct, ss.str(), batches[b], expected[b], 100);
+    }
+    deleteBatches(batches);
+  }
+
+  // Zero threads falls back to one thread, and more threads than work units per tick
+  unsigned int threadCounts[2] = { 0, 8 };
+  unsigned int bucketCounts[2] = { 4, 1 };
+  for (unsigned int i = 0; i < 2; i++) {
+    batches = createBatches(4, 100, expected);
+    printf("\nStarting pipelined bucket sort for 4 batches, listSize = %d, numBuckets = %d, numThreads = %d\n", 100, bucketCounts[i], threadCounts[i]);
+    pipelinedBucketSort(batches, 100, bucketCounts[i], threadCounts[i]);
+    for (unsigned int b = 0; b < batches.size(); b++) {
+      stringstream ss;
+      ss << "pipelined batch " << b << " of 4 with 100 items in " << bucketCounts[i] << " buckets on " << threadCounts[i] << " threads";
+      testBatchSort(testNum++, correct, ss.str(), batches[b], expected[b], 100);
+    }
+    deleteBatches(batches);
+  }
+
+  // A stream of 1M key batches.  In normal mode, also compare throughput against sorting them one at a time.
+  const unsigned int numBatches = runSpeedTests ? 16 : 3;
+  const unsigned int batchSize = 1000000;
+  numBuckets = 64;
+  numThreads = getNumThreadsToUse();
+  std::chrono::duration<double, std::milli> sequentialDiff{ 0 };
+
+  if (runSpeedTests) {
+    // One bucket array is cleared and reused between batches, as the pipeline reuses its bucket sets,
+    // so the comparison measures the overlap of the steps and not the allocations.
+    batches = createBatches(numBatches, batchSize, expected);
+    buckets = new vector<unsigned int>[numBuckets];
+    printf("\nStarting sequential bucket sorts for %d batches, listSize = %d, numBuckets = %d, numThreads = %d, number of cores = %d\n", numBatches, batchSize, numBuckets, numThreads, std::thread::hardware_concurrency());
+    auto start = std::chrono::high_resolution_clock::now();
+    for (unsigned int b = 0; b < numBatches; b++) {
+      arr = batches[b];
+      arrSize = batchSize;
+      multiThreadedBucketSort();
+      for (unsigned int i = 0; i < numBuckets; i++) {
+        buckets[i].clear();
+      }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    sequentialDiff = end - start;
+    arr = nullptr;
+    delete[] buckets;
+    deleteBatches(batches);
+  }
+
+  batches = createBatches(numBatches, batchSize, expected);
+  printf("\nStarting pipelined bucket sort for %d batches, listSize = %d, numBuckets = %d, numThreads = %d, number of cores = %d\n", numBatches, batchSize, numBuckets, numThreads, std::thread::hardware_concurrency());
+  auto start = std::chrono::high_resolution_clock::now();
+  pipelinedBucketSort(batches, batchSize, numBuckets, numThreads);
+  auto end = std::chrono::high_resolution_clock::now();
+  diff = end - start;
+  for (unsigned int b = 0; b < numBatches; b++) {
+    stringstream ss;
+    ss << "pipelined batch " << b << " of " << numBatches << " with " << batchSize << " items in " << numBuckets << " buckets";
+    testBatchSort(testNum++, correct, ss.str(), batches[b], expected[b], batchSize);
+  }
+  deleteBatches(batches);
+
+  if (runSpeedTests) {
+    double keys = (double)numBatches * batchSize;
+    printf("\n-----------------------------------------------------------\n");
+    printf("              PIPELINE RESULTS                      \n");
+    printf("Sequential multithreaded sorts: %d batches completed in %g ms (%g million keys/s)\n", numBatches, sequentialDiff.count(), keys / sequentialDiff.count() / 1000.0);
+    printf("Pipelined sort:                 %d batches completed in %g ms (%g million keys/s)\n", numBatches, diff.count(), keys / diff.count() / 1000.0);
+    printf("The pipelined speedup was %gx\n", sequentialDiff.count() / diff.count());
+    printf("\n-----------------------------------------------------------\n");
+  }
+
+  return testNum - 1 == correct;
+}
+
 int main(int argc, char** argv) {
 
   int test{ 0 };
@@ -278,6 +463,7 @@ int main(int argc, char** argv) {
   int largeSingleThreadedSort{ false };
   int smallMultiThreadedSorts{ false };
   int allTests{ false };
+  int pipelinedSorts{ false };
 
   if (argc > 1) {
     if (strcmp(argv[1], "valgrind_mode") == 0) {
@@ -315,18 +501,23 @@ int main(int argc, char** argv) {
       count++;
       allTests = true;
     }
+    if (testPipelinedSorts()) {
+      count++;
+      pipelinedSorts = true;
+    }
 
     cout << "----------------" << endl;
     if (!runSpeedTests) {
       cout << "No speed test summary in CTest or Valgrind mode" << endl;
     }
-    cout << "Passed " << count << " out of 4 group tests" << endl;
+    cout << "Passed " << count << " out of 5 group tests" << endl;
     if (!smallSingleThreadedSorts) { cout << "Failed smallSingleThreadedSorts group tests" << endl; }
     if (!largeSingleThreadedSort) { cout << "Failed largeSingleThreadedSort group tests" << endl; }
     if (!smallMultiThreadedSorts) { cout << "Failed smallMultiThreadedSorts group tests" << endl; }
     if (!allTests) { cout << "Failed testAll group tests" << endl; }
+    if (!pipelinedSorts) { cout << "Failed pipelinedSorts group tests" << endl; }
     cout << "--End of tests--" << endl;
-    return count != 4;
+    return count != 5;
   case 1:
     return (testSmallSingleThreadedSorts() > 0) ? 0 : 1;
   case 2:
@@ -335,5 +526,7 @@ int main(int argc, char** argv) {
     return (testSmallMultiThreadedSorts() > 0) ? 0 : 1;
   case 4:
     return (testAll() > 0) ? 0 : 1;
+  case 5:
+    return (testPipelinedSorts() > 0) ? 0 : 1;
   }
 }
\ No newline at end of file